@@ -0,0 +1,89 @@
+#!/bin/bash
+
+# =============================================================================
+# ECE 492 Cache Simulator Performance Check ("make perf")
+# =============================================================================
+# Times the same runs as check_golden.sh (val-proj1/ and extra_runs/ configs)
+# and reports simulated accesses/sec. Fails if throughput drops more than
+# PERF_TOLERANCE (default 0.10 = 10%) below the value stored in
+# perf_baseline.txt.
+#
+# Usage: ./perf_check.sh            compare against perf_baseline.txt
+#        ./perf_check.sh --update   store the measured throughput as baseline
+#
+# Each config is run PERF_REPEAT times (default 3) and the fastest run kept.
+# Each trace is concatenated PERF_TRACE_REPEAT times (default 20, ~2M
+# accesses) so a run takes ~100ms+ instead of a few ms of process startup.
+#
+# NOTE: perf_baseline.txt is a single number for ONE machine (and compiler).
+# It is only meaningful on the machine that wrote it; after switching
+# machines, run "make perf-baseline" on the old code first, then compare.
+
+cd "$(dirname "$0")"
+
+SIM=$(pwd)/sim
+BASELINE=perf_baseline.txt
+REPEAT=${PERF_REPEAT:-3}
+TRACE_REPEAT=${PERF_TRACE_REPEAT:-20}
+TOLERANCE=${PERF_TOLERANCE:-0.10}
+
+if [ ! -x sim ]; then
+    echo "ERROR: ./sim not built (run make)"
+    exit 1
+fi
+
+# Longer traces: each bundled trace repeated TRACE_REPEAT times
+trace_dir=$(mktemp -d)
+trap 'rm -rf "$trace_dir"' EXIT
+for trace in traces/*_trace.txt; do
+    for i in $(seq $TRACE_REPEAT); do cat "$trace"; done > "$trace_dir/$(basename "$trace")"
+done
+
+total_accesses=0
+total_ns=0
+
+for ref in val-proj1/*.txt extra_runs/*.txt; do
+    name=$(basename "$ref" .txt)
+    params=${name#*.}
+    trace=${params##*_}_trace.txt
+    config=$(echo "${params%_*}" | tr '_' ' ')
+    accesses=$(wc -l < "$trace_dir/$trace")
+
+    best_ns=0
+    for i in $(seq $REPEAT); do
+        start=$(date +%s%N)
+        (cd "$trace_dir" && $SIM $config $trace) > /dev/null || exit 1
+        end=$(date +%s%N)
+        ns=$((end - start))
+        if [ $best_ns -eq 0 ] || [ $ns -lt $best_ns ]; then
+            best_ns=$ns
+        fi
+    done
+
+    total_accesses=$((total_accesses + accesses))
+    total_ns=$((total_ns + best_ns))
+    awk -v n="$name" -v a="$accesses" -v t="$best_ns" \
+        'BEGIN { printf "  %-40s %8.1f ms %12.0f accesses/sec\n", n, t / 1e6, a / (t / 1e9) }'
+done
+
+rate=$(awk -v a="$total_accesses" -v t="$total_ns" 'BEGIN { printf "%.0f", a / (t / 1e9) }')
+echo
+echo "===== $total_accesses accesses (traces x$TRACE_REPEAT) in $((total_ns / 1000000)) ms: $rate accesses/sec ====="
+
+if [ "$1" = "--update" ]; then
+    echo "$rate" > $BASELINE
+    echo "Baseline updated ($BASELINE)"
+    exit 0
+fi
+
+if [ ! -f $BASELINE ]; then
+    echo "No $BASELINE (run make perf-baseline)"
+    exit 1
+fi
+
+baseline=$(cat $BASELINE)
+awk -v r="$rate" -v b="$baseline" -v tol="$TOLERANCE" 'BEGIN {
+    min = b * (1 - tol);
+    printf "Baseline %.0f accesses/sec, minimum %.0f (-%.0f%%): ", b, min, tol * 100;
+    if (r < min) { print "FAIL"; exit 1 }
+    print "PASS" }'
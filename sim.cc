@@ -4,6 +4,11 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <string.h>
+#include <thread>
+#include <atomic>
+#include <math.h>
+#include <algorithm>
 #include "sim.h"
 
 // =============================================================================
@@ -15,21 +20,49 @@
 // CacheSet Implementation
 // =============================================================================
 
-CacheSet::CacheSet(uint32_t assoc) : associativity(assoc) {
-    lines.resize(associativity);
+// Out-of-line definitions (needed when odr-used at -O0)
+const uint64_t CacheSet::VALID_BIT;
+const uint64_t CacheSet::DIRTY_BIT;
 
-    // Init all lines as inv. w/ LRU positions
+void CacheSet::reset() {
+    if (index) {
+        // All ways invalid: empty table and list, no way filled yet
+        for (uint32_t i = 0; i < index->table_size; i++) {
+            setEntry(i, 0);
+        }
+        setPrev(associativity, associativity);
+        setNext(associativity, associativity);
+        setEntry(index->fill_offset, 0);
+        for (uint32_t i = 0; i < associativity; i++) {
+            store(i, 0);
+        }
+        return;
+    }
+    
+    // Init all lines as inv. w/ LRU positions (0 = MRU)
     for (uint32_t i = 0; i < associativity; i++) {
-        lines[i].valid = false;
-        lines[i].dirty = false;
-        lines[i].tag = 0;
-        lines[i].lru_position = i;  // (0 = MRU)
+        store(i, (uint64_t)i << 2);
     }
 }
 
 bool CacheSet::findLine(uint32_t tag, uint32_t& way) {
+    if (index) {
+        for (uint32_t slot = homeSlot(tag); ; slot = nextSlot(slot)) {
+            uint32_t e = entry(slot);
+            if (e == 0) return false;
+            if (tagOf(load(e - 1)) == tag) {
+                way = e - 1;
+                return true;
+            }
+        }
+    }
+    
+    // Valid bit and tag compared in one masked test
+    const uint64_t match_mask = format->tag_mask | VALID_BIT;
+    const uint64_t match = ((uint64_t)tag << format->tag_shift) | VALID_BIT;
+    
     for (uint32_t i = 0; i < associativity; i++) {
-        if (lines[i].valid && lines[i].tag == tag) {
+        if ((load(i) & match_mask) == match) {
             way = i;
             return true;
         }
@@ -38,12 +71,15 @@ bool CacheSet::findLine(uint32_t tag, uint32_t& way) {
 }
 
 uint32_t CacheSet::findLRUWay() {
+    if (index) return prevOf(associativity);
+    
     uint32_t lru_way = 0;
-    uint32_t max_lru_pos = lines[0].lru_position;
+    uint32_t max_lru_pos = lruOf(load(0));
     
     for (uint32_t i = 1; i < associativity; i++) {
-        if (lines[i].lru_position > max_lru_pos) {
-            max_lru_pos = lines[i].lru_position;
+        uint32_t pos = lruOf(load(i));
+        if (pos > max_lru_pos) {
+            max_lru_pos = pos;
             lru_way = i;
         }
     }
@@ -51,29 +87,62 @@ uint32_t CacheSet::findLRUWay() {
 }
 
 void CacheSet::updateLRU(uint32_t way) {
-    uint32_t old_position = lines[way].lru_position;
+    if (index) {
+        if (nextOf(associativity) != way) {
+            unlinkWay(way);
+            pushMRU(way);
+        }
+        return;
+    }
+    
+    uint32_t old_position = lruOf(load(way));
     
     // Move all lines with position < old_position up by 1
     for (uint32_t i = 0; i < associativity; i++) {
-        if (lines[i].lru_position < old_position) {
-            lines[i].lru_position++;
+        uint64_t line = load(i);
+        if (lruOf(line) < old_position) {
+            store(i, line + (1 << 2));
         }
     }
     
     // Set accessed line to MRU (position 0)
-    lines[way].lru_position = 0;
+    store(way, load(way) & ~format->lru_mask);
 }
 
 bool CacheSet::insertLine(uint32_t tag, bool& eviction_needed, uint32_t& evicted_tag, bool& evicted_dirty) {
     eviction_needed = false;
     evicted_dirty = false;
     
+    if (index) {
+        // 1. Lowest invalid way (same choice as the linear scan)
+        uint32_t filled = entry(index->fill_offset);
+        if (filled < associativity) {
+            setEntry(index->fill_offset, filled + 1);
+            store(filled, ((uint64_t)tag << format->tag_shift) | VALID_BIT);
+            tableInsert(tag, filled);
+            pushMRU(filled);
+            return true;
+        }
+        
+        // 2. All lines are valid: Replace LRU line (erase while its old tag is still stored)
+        uint32_t lru_way = prevOf(associativity);
+        uint64_t victim = load(lru_way);
+        eviction_needed = true;
+        evicted_tag = tagOf(victim);
+        evicted_dirty = (victim & DIRTY_BIT) != 0;
+        
+        tableErase(evicted_tag);
+        store(lru_way, ((uint64_t)tag << format->tag_shift) | VALID_BIT);
+        tableInsert(tag, lru_way);
+        updateLRU(lru_way);
+        return true;
+    }
+    
     // 1. Find invalid line
     for (uint32_t i = 0; i < associativity; i++) {
-        if (!lines[i].valid) {
-            lines[i].valid = true;
-            lines[i].tag = tag;
-            lines[i].dirty = false;
+        uint64_t line = load(i);
+        if (!(line & VALID_BIT)) {
+            store(i, ((uint64_t)tag << format->tag_shift) | (line & format->lru_mask) | VALID_BIT);
             updateLRU(i);
             return true;
         }
@@ -81,52 +150,113 @@ bool CacheSet::insertLine(uint32_t tag, bool& eviction_needed, uint32_t& evicted
     
     // All lines are valid: Evict LRU
     uint32_t lru_way = findLRUWay();
+    uint64_t victim = load(lru_way);
     eviction_needed = true;
-    evicted_tag = lines[lru_way].tag;
-    evicted_dirty = lines[lru_way].dirty;
+    evicted_tag = tagOf(victim);
+    evicted_dirty = (victim & DIRTY_BIT) != 0;
     
     // 2. Replace LRU line
-    lines[lru_way].tag = tag;
-    lines[lru_way].dirty = false;
+    store(lru_way, ((uint64_t)tag << format->tag_shift) | (victim & format->lru_mask) | VALID_BIT);
     updateLRU(lru_way);
     
     return true;
 }  
 
 void CacheSet::setDirty(uint32_t way, bool dirty) {
-    lines[way].dirty = dirty;
+    uint64_t line = load(way);
+    store(way, dirty ? (line | DIRTY_BIT) : (line & ~DIRTY_BIT));
 }
 
 bool CacheSet::isDirty(uint32_t way) {
-    return lines[way].dirty;
+    return (load(way) & DIRTY_BIT) != 0;
 }
 
-void CacheSet::displaySet(uint32_t set_index) {
-    std::cout << "set" << std::setw(6) << set_index << ":";
+void CacheSet::unlinkWay(uint32_t way) {
+    uint32_t p = prevOf(way);
+    uint32_t n = nextOf(way);
+    setNext(p, n);
+    setPrev(n, p);
+}
+
+void CacheSet::pushMRU(uint32_t way) {
+    uint32_t head = nextOf(associativity);
+    setPrev(way, associativity);
+    setNext(way, head);
+    setPrev(head, way);
+    setNext(associativity, way);
+}
+
+void CacheSet::tableInsert(uint32_t tag, uint32_t way) {
+    uint32_t slot = homeSlot(tag);
+    while (entry(slot) != 0) slot = nextSlot(slot);
+    setEntry(slot, way + 1);
+}
+
+void CacheSet::tableErase(uint32_t tag) {
+    const uint32_t size = index->table_size;
+    uint32_t hole = homeSlot(tag);
+    while (tagOf(load(entry(hole) - 1)) != tag) hole = nextSlot(hole);
     
-    // Sort by LRU position (0 = MRU, highest = LRU)
-    std::vector<uint32_t> ways_by_lru(associativity);
-    for (uint32_t i = 0; i < associativity; i++) {
-        ways_by_lru[i] = i;
+    // Backward-shift deletion: pull later entries of the probe run into the hole
+    // unless their home slot lies cyclically in (hole, slot]
+    for (uint32_t slot = nextSlot(hole); ; slot = nextSlot(slot)) {
+        uint32_t e = entry(slot);
+        if (e == 0) break;
+        uint32_t home = homeSlot(tagOf(load(e - 1)));
+        uint32_t from_home = (slot >= home) ? slot - home : slot + size - home;
+        uint32_t from_hole = (slot >= hole) ? slot - hole : slot + size - hole;
+        if (from_home >= from_hole) {
+            setEntry(hole, e);
+            hole = slot;
+        }
     }
+    setEntry(hole, 0);
+}
+
+CacheLine CacheSet::getLine(uint32_t way) {
+    uint64_t packed = load(way);
+    CacheLine line;
+    line.valid = (packed & VALID_BIT) != 0;
+    line.dirty = (packed & DIRTY_BIT) != 0;
+    line.tag = tagOf(packed);
+    line.lru_position = lruOf(packed);
+    return line;
+}
+
+void CacheSet::displaySet(uint32_t set_index) {
+    std::cout << "set" << std::dec << std::setw(7) << set_index << ": ";
+    
+    std::vector<CacheLine> ways_by_lru;
     
-    // Sort by LRU position (bub)
-    for (uint32_t i = 0; i < associativity - 1; i++) {
-        for (uint32_t j = 0; j < associativity - i - 1; j++) {
-            if (lines[ways_by_lru[j]].lru_position > lines[ways_by_lru[j+1]].lru_position) {
-                uint32_t temp = ways_by_lru[j];
-                ways_by_lru[j] = ways_by_lru[j+1];
-                ways_by_lru[j+1] = temp;
+    if (index) {
+        // LRU list is already in order (MRU first, valid lines only)
+        for (uint32_t way = nextOf(associativity); way != associativity; way = nextOf(way)) {
+            ways_by_lru.push_back(getLine(way));
+        }
+    } else {
+        // Sort by LRU position (0 = MRU, highest = LRU)
+        for (uint32_t i = 0; i < associativity; i++) {
+            ways_by_lru.push_back(getLine(i));
+        }
+        
+        // Sort by LRU position (bub)
+        for (uint32_t i = 0; i < associativity - 1; i++) {
+            for (uint32_t j = 0; j < associativity - i - 1; j++) {
+                if (ways_by_lru[j].lru_position > ways_by_lru[j+1].lru_position) {
+                    CacheLine temp = ways_by_lru[j];
+                    ways_by_lru[j] = ways_by_lru[j+1];
+                    ways_by_lru[j+1] = temp;
+                }
             }
         }
     }
     
     // Display in LRU order
-    for (uint32_t i = 0; i < associativity; i++) {
-        uint32_t way = ways_by_lru[i];
-        if (lines[way].valid) {
-            std::cout << "   " << std::hex << lines[way].tag;
-            if (lines[way].dirty) {
+    for (uint32_t i = 0; i < ways_by_lru.size(); i++) {
+        const CacheLine& line = ways_by_lru[i];
+        if (line.valid) {
+            std::cout << std::hex << std::setw(8) << line.tag << std::dec;
+            if (line.dirty) {
                 std::cout << " D";
             } else {
                 std::cout << "  ";
@@ -136,6 +266,24 @@ void CacheSet::displaySet(uint32_t set_index) {
     std::cout << std::endl;
 }
 
+// HighAssocIndex Implementation
+// =============================================================================
+
+void HighAssocIndex::init(uint32_t num_sets, uint32_t assoc) {
+    table_size = assoc + assoc / 2 + 1;
+    prev_offset = table_size;
+    next_offset = prev_offset + assoc + 1;
+    fill_offset = next_offset + assoc + 1;
+    stride = fill_offset + 1;
+    
+    // Way + 1 and the sentinel (assoc) must fit an entry
+    if (assoc <= 0xFFFF) {
+        narrow.assign(stride * num_sets, 0);
+    } else {
+        wide.assign(stride * num_sets, 0);
+    }
+}
+
 // Cache Implementation
 // =============================================================================
 
@@ -156,11 +304,15 @@ Cache::Cache(uint32_t size, uint32_t block_sz, uint32_t assoc)
     
     // Calculate bit fields for address parsing
     calculateBitFields();
+    calculateLineFormat();
     
     // Initialize cache sets
-    sets.reserve(num_sets);
+    line_words.assign((size_t)num_sets * associativity * line_format.words_per_line, 0);
+    if (associativity > HIGH_ASSOC_THRESHOLD) {
+        high_assoc_index.init(num_sets, associativity);
+    }
     for (uint32_t i = 0; i < num_sets; i++) {
-        sets.push_back(CacheSet(associativity));
+        set(i).reset();
     }
 }
 
@@ -185,6 +337,20 @@ void Cache::calculateBitFields() {
     tag_bits = 32 - offset_bits - index_bits;
 }
 
+void Cache::calculateLineFormat() {
+    // LRU rank bits - ceil(log2(associativity)); none when HighAssocIndex keeps LRU order
+    line_format.lru_bits = 0;
+    while (associativity <= HIGH_ASSOC_THRESHOLD && (1ULL << line_format.lru_bits) < associativity) {
+        line_format.lru_bits++;
+    }
+    
+    // valid + dirty + rank + tag: one 32-bit word if it fits, else 64-bit
+    line_format.tag_shift = 2 + line_format.lru_bits;
+    line_format.words_per_line = (line_format.tag_shift + tag_bits <= 32) ? 1 : 2;
+    line_format.lru_mask = ((1ULL << line_format.lru_bits) - 1) << 2;
+    line_format.tag_mask = ((1ULL << tag_bits) - 1) << line_format.tag_shift;
+}
+
 void Cache::extractAddressBits(uint32_t addr, uint32_t& tag, uint32_t& index, uint32_t& offset) {
     offset = addr & ((1 << offset_bits) - 1);
     index = (addr >> offset_bits) & ((1 << index_bits) - 1);
@@ -207,16 +373,16 @@ bool Cache::access(uint32_t address, char rw, bool& writeback_needed, uint32_t&
     
     // Check if line exists in cache
     uint32_t way;
-    bool hit = sets[index].findLine(tag, way);
+    bool hit = set(index).findLine(tag, way);
     
     if (hit) {
         // Cache hit
-        sets[index].updateLRU(way);
+        set(index).updateLRU(way);
         if (rw == 'r') {
             read_hits++;
         } else {
             write_hits++;
-            sets[index].setDirty(way, true);  // Mark as dirty on write
+            set(index).setDirty(way, true);  // Mark as dirty on write
         }
         return true;
     } else {
@@ -232,7 +398,7 @@ bool Cache::access(uint32_t address, char rw, bool& writeback_needed, uint32_t&
         uint32_t evicted_tag;
         bool evicted_dirty;
         
-        sets[index].insertLine(tag, eviction_needed, evicted_tag, evicted_dirty);
+        set(index).insertLine(tag, eviction_needed, evicted_tag, evicted_dirty);
         
         // If we evicted a dirty line, need writeback
         if (eviction_needed && evicted_dirty) {
@@ -244,8 +410,8 @@ bool Cache::access(uint32_t address, char rw, bool& writeback_needed, uint32_t&
         // For writes, mark the new line as dirty
         if (rw == 'w') {
             uint32_t new_way;
-            sets[index].findLine(tag, new_way);  // Find the line we just inserted
-            sets[index].setDirty(new_way, true);
+            set(index).findLine(tag, new_way);  // Find the line we just inserted
+            set(index).setDirty(new_way, true);
         }
         
         return false;
@@ -260,7 +426,7 @@ void Cache::printStats(const char* cache_name) {
 void Cache::displayContents(const char* cache_name) {
     std::cout << "===== " << cache_name << " contents =====" << std::endl;
     for (uint32_t i = 0; i < num_sets; i++) {
-        sets[i].displaySet(i);
+        set(i).displaySet(i);
     }
     std::cout << std::endl;
 }
@@ -272,6 +438,11 @@ double Cache::getMissRate() {
     return (double)total_misses / (double)total_accesses;
 }
 
+double Cache::getReadMissRate() {
+    if (read_accesses == 0) return 0.0;
+    return (double)read_misses / (double)read_accesses;
+}
+
 uint64_t Cache::getTotalMisses() {
     return read_misses + write_misses;
 }
@@ -286,6 +457,12 @@ CacheSimulator::CacheSimulator(const cache_params_t& params, bool debug)
     total_accesses = 0;
     memory_traffic = 0;
     access_count = 0;
+    miss_stream = nullptr;
+    sampling = false;
+    sample_rate = 1;
+    sample_seed = 0;
+    sample_modulus = 1;
+    skipped_accesses = 0;
     
     // Create L1 cache
     L1_cache = new Cache(params.L1_SIZE, params.BLOCKSIZE, params.L1_ASSOC);
@@ -305,10 +482,95 @@ CacheSimulator::~CacheSimulator() {
     }
 }
 
+// Integer hash for choosing sampled residues (lowbias32)
+static uint32_t mixIndex(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+bool CacheSimulator::setSampleRate(uint32_t rate, uint32_t seed) {
+    uint32_t l1_sets = L1_cache->getNumSets();
+    
+    // Selection depends only on index % modulus, where modulus divides both set
+    // counts: a selected residue picks the same blocks in L1 and L2, so sampled
+    // L1 sets send their misses to exactly the L2 sets they use in a full run
+    uint32_t modulus = l1_sets;
+    if (L2_cache && L2_cache->getNumSets() < modulus) {
+        modulus = L2_cache->getNumSets();
+    }
+    
+    if (rate == 0 || (rate & (rate - 1)) != 0) return false;
+    if (modulus / rate < 2) return false;  // Need >= 2 clusters for a CI
+    
+    // Pick modulus/rate residues: every rate-th (seed 0) or lowest hash keys
+    std::vector<std::pair<uint32_t, uint32_t> > keys(modulus);
+    for (uint32_t r = 0; r < modulus; r++) {
+        uint32_t key = (seed == 0) ? ((r % rate) * modulus + r) : mixIndex(r ^ (seed * 0x9e3779b9));
+        keys[r] = std::make_pair(key, r);
+    }
+    std::sort(keys.begin(), keys.end());
+    
+    residue_sampled.assign(modulus, 0);
+    sampled_residues.clear();
+    for (uint32_t i = 0; i < modulus / rate; i++) {
+        residue_sampled[keys[i].second] = 1;
+        sampled_residues.push_back(keys[i].second);
+    }
+    
+    sampling = true;
+    sample_rate = rate;
+    sample_seed = seed;
+    sample_modulus = modulus;
+    cluster_accesses.assign(modulus, 0);
+    cluster_misses.assign(modulus, 0);
+    cluster_traffic.assign(modulus, 0);
+    cluster_l2_accesses.assign(modulus, 0);
+    cluster_l2_misses.assign(modulus, 0);
+    return true;
+}
+
 void CacheSimulator::processMemoryAccess(uint32_t address, char rw) {
     total_accesses++;
     access_count++;
     
+    if (sampling) {
+        uint32_t tag, index, offset;
+        L1_cache->extractAddressBits(address, tag, index, offset);
+        
+        // Unsampled set: never reaches L1 or L2
+        uint32_t residue = index & (sample_modulus - 1);
+        if (!residue_sampled[residue]) {
+            skipped_accesses++;
+            return;
+        }
+        
+        // Attribute this access's effects to its residue (one sampling cluster)
+        uint64_t misses_before = L1_cache->getTotalMisses();
+        uint64_t traffic_before = memoryTraffic();
+        uint64_t l2_reads_before = L2_cache ? L2_cache->getReadAccesses() : 0;
+        uint64_t l2_read_misses_before = L2_cache ? L2_cache->getReadMisses() : 0;
+        
+        simulateAccess(address, rw);
+        
+        cluster_accesses[residue]++;
+        cluster_misses[residue] += L1_cache->getTotalMisses() - misses_before;
+        cluster_traffic[residue] += memoryTraffic() - traffic_before;
+        if (L2_cache) {
+            cluster_l2_accesses[residue] += L2_cache->getReadAccesses() - l2_reads_before;
+            cluster_l2_misses[residue] += L2_cache->getReadMisses() - l2_read_misses_before;
+        }
+        return;
+    }
+    
+    simulateAccess(address, rw);
+}
+
+void CacheSimulator::simulateAccess(uint32_t address, char rw) {
+
     if (debug_mode) {
         std::cout << access_count << "=" << rw << " " << std::hex << address << std::endl;
     }
@@ -340,37 +602,52 @@ void CacheSimulator::processMemoryAccess(uint32_t address, char rw) {
 void CacheSimulator::handleL1Miss(uint32_t address, char rw, bool writeback_needed, uint32_t writeback_addr) {
     // Handle writeback first if needed
     if (writeback_needed) {
-        if (L2_cache) {
-            bool l2_writeback_needed = false;
-            uint32_t l2_writeback_addr = 0;
-            L2_cache->access(writeback_addr, 'w', l2_writeback_needed, l2_writeback_addr);
-            
-            if (l2_writeback_needed) {
-                memory_traffic++;  // Writeback to memory
-            }
-        } else {
-            memory_traffic++;  // Direct writeback to memory
+        if (miss_stream) {
+            miss_stream->record(writeback_addr, 'w');
         }
+        accessL2(writeback_addr, 'w');
     }
     
-    // Now handle the original miss
-    if (L2_cache) {
-        bool l2_writeback_needed = false;
-        uint32_t l2_writeback_addr = 0;
-        bool l2_hit = L2_cache->access(address, 'r', l2_writeback_needed, l2_writeback_addr);  // Always read from L2
-        
-        if (l2_hit) {
-            // L2 hit - handle potential L2 writeback
-            if (l2_writeback_needed) {
-                memory_traffic++;  // Writeback to memory
-            }
-        } else {
-            // L2 miss - go to memory
-            handleL2Miss(address, rw, l2_writeback_needed, l2_writeback_addr);
-        }
-    } else {
+    // Now handle the original miss (always a read from L2)
+    if (miss_stream) {
+        miss_stream->record(address, 'r');
+    }
+    accessL2(address, 'r');
+}
+
+void CacheSimulator::accessL2(uint32_t address, char rw) {
+    if (!L2_cache) {
         // No L2 - go directly to memory
         memory_traffic++;
+        return;
+    }
+    
+    bool l2_writeback_needed = false;
+    uint32_t l2_writeback_addr = 0;
+    bool l2_hit = L2_cache->access(address, rw, l2_writeback_needed, l2_writeback_addr);
+    
+    if (rw == 'w') {
+        // L1 writeback - only an L2 writeback reaches memory
+        if (l2_writeback_needed) {
+            memory_traffic++;
+        }
+    } else if (l2_hit) {
+        // L2 hit - handle potential L2 writeback
+        if (l2_writeback_needed) {
+            memory_traffic++;  // Writeback to memory
+        }
+    } else {
+        // L2 miss - go to memory
+        handleL2Miss(address, rw, l2_writeback_needed, l2_writeback_addr);
+    }
+}
+
+void CacheSimulator::replayMissStream(const L1MissStream& stream, const Cache& l1_snapshot) {
+    // L1 state/stats are identical for every L2 config: copy, don't resimulate
+    *L1_cache = l1_snapshot;
+    
+    for (size_t i = 0; i < stream.size(); i++) {
+        accessL2(stream[i].address, stream[i].rw);
     }
 }
 
@@ -385,28 +662,32 @@ void CacheSimulator::handleL2Miss(uint32_t address, char rw, bool writeback_need
 }
 
 void CacheSimulator::printFinalStats() {
+    // Sampled runs scale counts up by the sampling rate (1 = full run)
+    uint64_t scale = sample_rate;
+    
     std::cout << "===== Measurements =====" << std::endl;
     
     // L1 Statistics (ensure decimal output)
     std::cout << std::dec;  // Set to decimal mode
-    std::cout << "a. L1 reads:                   " << L1_cache->getReadAccesses() << std::endl;
-    std::cout << "b. L1 read misses:             " << L1_cache->getReadMisses() << std::endl;
-    std::cout << "c. L1 writes:                  " << L1_cache->getWriteAccesses() << std::endl;
-    std::cout << "d. L1 write misses:            " << L1_cache->getWriteMisses() << std::endl;
+    std::cout << "a. L1 reads:                   " << L1_cache->getReadAccesses() * scale << std::endl;
+    std::cout << "b. L1 read misses:             " << L1_cache->getReadMisses() * scale << std::endl;
+    std::cout << "c. L1 writes:                  " << L1_cache->getWriteAccesses() * scale << std::endl;
+    std::cout << "d. L1 write misses:            " << L1_cache->getWriteMisses() * scale << std::endl;
     std::cout << "e. L1 miss rate:               " << std::fixed << std::setprecision(4) << L1_cache->getMissRate() << std::endl;
-    std::cout << "f. L1 writebacks:              " << L1_cache->getWritebacks() << std::endl;
+    std::cout << "f. L1 writebacks:              " << L1_cache->getWritebacks() * scale << std::endl;
     std::cout << "g. L1 prefetches:              " << 0 << std::endl;  // No prefetching in this implementation
     
     // L2 Statistics
     if (L2_cache) {
-        std::cout << "h. L2 reads (demand):          " << L2_cache->getReadAccesses() + L2_cache->getWriteAccesses() << std::endl;
-        std::cout << "i. L2 read misses (demand):    " << L2_cache->getTotalMisses() << std::endl;
+        // L2 reads are L1 demand misses, L2 writes are L1 writebacks
+        std::cout << "h. L2 reads (demand):          " << L2_cache->getReadAccesses() * scale << std::endl;
+        std::cout << "i. L2 read misses (demand):    " << L2_cache->getReadMisses() * scale << std::endl;
         std::cout << "j. L2 reads (prefetch):        " << 0 << std::endl;
         std::cout << "k. L2 read misses (prefetch):  " << 0 << std::endl;
-        std::cout << "l. L2 writes:                  " << 0 << std::endl;  // L2 writes are writebacks from L1
-        std::cout << "m. L2 write misses:            " << 0 << std::endl;
-        std::cout << "n. L2 miss rate:               " << std::fixed << std::setprecision(4) << L2_cache->getMissRate() << std::endl;
-        std::cout << "o. L2 writebacks:              " << L2_cache->getWritebacks() << std::endl;
+        std::cout << "l. L2 writes:                  " << L2_cache->getWriteAccesses() * scale << std::endl;
+        std::cout << "m. L2 write misses:            " << L2_cache->getWriteMisses() * scale << std::endl;
+        std::cout << "n. L2 miss rate:               " << std::fixed << std::setprecision(4) << L2_cache->getReadMissRate() << std::endl;
+        std::cout << "o. L2 writebacks:              " << L2_cache->getWritebacks() * scale << std::endl;
         std::cout << "p. L2 prefetches:              " << 0 << std::endl;
     } else {
         std::cout << "h. L2 reads (demand):          " << 0 << std::endl;
@@ -420,6 +701,10 @@ void CacheSimulator::printFinalStats() {
         std::cout << "p. L2 prefetches:              " << 0 << std::endl;
     }
     
+    std::cout << "q. memory traffic:             " << memoryTraffic() * scale << std::endl;
+}
+
+uint64_t CacheSimulator::memoryTraffic() {
     // Memory traffic calculation: L1 misses + writebacks - L2 hits (if L2 exists)
     uint64_t calculated_traffic = L1_cache->getTotalMisses() + L1_cache->getWritebacks();
     if (L2_cache) {
@@ -428,8 +713,95 @@ void CacheSimulator::printFinalStats() {
         uint64_t l2_hits = l2_accesses - L2_cache->getTotalMisses();
         calculated_traffic = L1_cache->getTotalMisses() + L1_cache->getWritebacks() - l2_hits + L2_cache->getWritebacks();
     }
+    return calculated_traffic;
+}
+
+// Two-sided 95% Student-t critical value (few sampled sets => wider interval)
+static double tCritical95(double df) {
+    static const double table[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (df < 1) return table[0];
+    if (df <= 30) return table[(int)df - 1];
+    return 1.96;
+}
+
+// 95% CI half-width of a cluster-sampled ratio sum(num)/sum(den); < 0 if undefined.
+// Clusters are the sampled residues, n of N = n * sample_rate. Jackknife
+// variance: less optimistic than linearization when a few clusters dominate.
+static double ratioHalfWidth(const std::vector<uint64_t>& num, const std::vector<uint64_t>& den,
+                             const std::vector<uint32_t>& clusters, uint32_t sample_rate) {
+    double n = clusters.size(), num_sum = 0, den_sum = 0;
+    for (size_t i = 0; i < clusters.size(); i++) {
+        num_sum += (double)num[clusters[i]];
+        den_sum += (double)den[clusters[i]];
+    }
+    if (n < 2 || den_sum == 0) return -1.0;
+    
+    // Leave-one-cluster-out ratios
+    std::vector<double> loo;
+    for (size_t i = 0; i < clusters.size(); i++) {
+        double d = den_sum - (double)den[clusters[i]];
+        if (d == 0) return -1.0;
+        loo.push_back((num_sum - (double)num[clusters[i]]) / d);
+    }
+    double mean = 0, var = 0;
+    for (size_t i = 0; i < loo.size(); i++) mean += loo[i];
+    mean /= n;
+    for (size_t i = 0; i < loo.size(); i++) var += (loo[i] - mean) * (loo[i] - mean);
+    var *= (n - 1) / n;
     
-    std::cout << "q. memory traffic:             " << calculated_traffic << std::endl;
+    double fpc = 1.0 - 1.0 / (double)sample_rate;  // Finite population correction
+    return tCritical95(n - 1) * sqrt(fpc * var);
+}
+
+// 95% CI half-width of the scaled total N * mean(x); < 0 if undefined.
+static double totalHalfWidth(const std::vector<uint64_t>& x, const std::vector<uint32_t>& clusters,
+                             uint32_t sample_rate) {
+    // var = N^2 (1-f) s^2 / n
+    double n = clusters.size(), sum = 0, sum_sq = 0;
+    for (size_t i = 0; i < clusters.size(); i++) {
+        double v = (double)x[clusters[i]];
+        sum += v;
+        sum_sq += v * v;
+    }
+    if (n < 2) return -1.0;
+    
+    double var = (sum_sq - sum * sum / n) / (n - 1);
+    double fpc = 1.0 - 1.0 / (double)sample_rate;
+    double population = n * sample_rate;
+    return tCritical95(n - 1) * population * sqrt(fpc * (var > 0 ? var : 0) / n);
+}
+
+// " +/- <half-width>" or " +/- undefined"
+static void printHalfWidth(double half_width, int precision) {
+    if (half_width < 0) {
+        std::cout << " +/- undefined";
+    } else {
+        std::cout << " +/- " << std::fixed << std::setprecision(precision) << half_width;
+    }
+}
+
+void CacheSimulator::printSamplingStats() {
+    uint32_t num_sets = L1_cache->getNumSets();
+    
+    std::cout << std::endl << "===== Sampling =====" << std::endl;
+    std::cout << std::dec;
+    std::cout << "sampled sets:                  " << num_sets / sample_rate << " of " << num_sets
+              << " (1/" << sample_rate << ", seed " << sample_seed << ", " << sampled_residues.size()
+              << " clusters)" << std::endl;
+    std::cout << "simulated accesses:            " << total_accesses - skipped_accesses << " of " << total_accesses << std::endl;
+    
+    std::cout << "L1 miss rate (95% CI):         " << std::fixed << std::setprecision(4) << L1_cache->getMissRate();
+    printHalfWidth(ratioHalfWidth(cluster_misses, cluster_accesses, sampled_residues, sample_rate), 4);
+    std::cout << std::endl;
+    if (L2_cache) {
+        std::cout << "L2 miss rate (95% CI):         " << std::fixed << std::setprecision(4) << L2_cache->getReadMissRate();
+        printHalfWidth(ratioHalfWidth(cluster_l2_misses, cluster_l2_accesses, sampled_residues, sample_rate), 4);
+        std::cout << std::endl;
+    }
+    std::cout << "memory traffic (95% CI):       " << memoryTraffic() * sample_rate;
+    printHalfWidth(totalHalfWidth(cluster_traffic, sampled_residues, sample_rate), 0);
     std::cout << std::endl;
 }
 
@@ -440,6 +812,237 @@ void CacheSimulator::printCacheContents() {
     }
 }
 
+// TraceReader Implementation
+// =============================================================================
+
+static const size_t TRACE_BUFFER_BYTES = 1 << 20;
+static const size_t TRACE_MAX_LINE = 256;
+
+TraceReader::TraceReader(FILE* file)
+    : fp(file), buffer(TRACE_BUFFER_BYTES), pos(0), len(0),
+      filter_keep(nullptr), filter_shift(0), filter_digits(0), filtered_lines(0) {}
+
+void TraceReader::setSampleFilter(uint32_t shift, const std::vector<uint8_t>* keep) {
+    uint32_t residue_bits = 0;
+    while ((1U << residue_bits) < keep->size()) residue_bits++;
+    
+    filter_keep = keep;
+    filter_shift = shift;
+    filter_digits = (shift + residue_bits + 3) / 4;
+}
+
+bool TraceReader::fill() {
+    if (len - pos >= TRACE_MAX_LINE) return true;
+    
+    // Move the unread tail to the front and top up from the file
+    memmove(&buffer[0], &buffer[pos], len - pos);
+    len -= pos;
+    pos = 0;
+    len += fread(&buffer[len], 1, buffer.size() - len, fp);
+    return len > 0;
+}
+
+// Character classes for the trace parser: hex digit value, TRACE_SPACE, or TRACE_OTHER
+static const uint8_t TRACE_SPACE = 0x10;
+static const uint8_t TRACE_OTHER = 0x20;
+
+struct TraceCharTable {
+    uint8_t cls[256];
+    
+    TraceCharTable() {
+        for (int c = 0; c < 256; c++) cls[c] = TRACE_OTHER;
+        for (int c = '0'; c <= '9'; c++) cls[c] = c - '0';
+        for (int c = 'a'; c <= 'f'; c++) cls[c] = c - 'a' + 10;
+        for (int c = 'A'; c <= 'F'; c++) cls[c] = c - 'A' + 10;
+        cls[(int)' '] = cls[(int)'\t'] = cls[(int)'\n'] = cls[(int)'\r'] = cls[(int)'\v'] = cls[(int)'\f'] = TRACE_SPACE;
+    }
+};
+static const TraceCharTable trace_chars;
+
+bool TraceReader::skipFiltered() {
+    const std::vector<uint8_t>& keep = *filter_keep;
+    const uint32_t mask = keep.size() - 1;
+    
+    while (fill()) {
+        const char* line = &buffer[pos];
+        const char* nl = (const char*)memchr(line, '\n', len - pos);
+        if ((line[0] != 'r' && line[0] != 'w') || nl == NULL) return true;  // Full parse
+        
+        // Only the trailing hex digits of the address are needed for the residue
+        const char* e = nl;
+        while (e > line && trace_chars.cls[(uint8_t)e[-1]] == TRACE_SPACE) e--;
+        uint32_t low = 0;
+        for (uint32_t d = 0; d < filter_digits; d++) {
+            uint8_t cls = (e > line + 1) ? trace_chars.cls[(uint8_t)*--e] : TRACE_OTHER;
+            if (cls >= 16) {
+                if (cls != TRACE_SPACE && *e != 'x' && *e != 'X') return true;
+                break;  // Address shorter than filter_digits: upper digits are 0
+            }
+            low |= (uint32_t)cls << (4 * d);
+        }
+        if (keep[(low >> filter_shift) & mask]) return true;
+        
+        // Rejected: move to the next request
+        pos = nl + 1 - &buffer[0];
+        while (pos < len && trace_chars.cls[(uint8_t)buffer[pos]] == TRACE_SPACE) pos++;
+        filtered_lines++;
+    }
+    return false;
+}
+
+bool TraceReader::next(char& rw, uint32_t& addr) {
+    if (filter_keep && !skipFiltered()) return false;
+    if (!fill()) return false;
+    
+    const uint8_t* p = (const uint8_t*)&buffer[pos];
+    const uint8_t* end = (const uint8_t*)&buffer[len];
+    
+    // Request type, then whitespace
+    rw = (char)*p++;
+    while (p < end && trace_chars.cls[*p] == TRACE_SPACE) p++;
+    
+    // Hex address (optional 0x prefix)
+    if (p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) p += 2;
+    if (p >= end || trace_chars.cls[*p] >= 16) {
+        pos = (const char*)p - &buffer[0];
+        return false;
+    }
+    addr = 0;
+    uint8_t digit;
+    while (p < end && (digit = trace_chars.cls[*p]) < 16) {
+        addr = (addr << 4) | digit;
+        p++;
+    }
+    
+    // Trailing whitespace / newline
+    while (p < end && trace_chars.cls[*p] == TRACE_SPACE) p++;
+    pos = (const char*)p - &buffer[0];
+    return true;
+}
+
+// =============================================================================
+// L2 SWEEP MODE
+// =============================================================================
+
+// Print simulator configuration (same header as a normal run).
+static void printConfiguration(const cache_params_t& params, const char* trace_file) {
+   printf("===== Simulator configuration =====\n");
+   printf("BLOCKSIZE:  %u\n", params.BLOCKSIZE);
+   printf("L1_SIZE:    %u\n", params.L1_SIZE);
+   printf("L1_ASSOC:   %u\n", params.L1_ASSOC);
+   printf("L2_SIZE:    %u\n", params.L2_SIZE);
+   printf("L2_ASSOC:   %u\n", params.L2_ASSOC);
+   printf("PREF_N:     %u\n", params.PREF_N);
+   printf("PREF_M:     %u\n", params.PREF_M);
+   printf("trace_file: %s\n", trace_file);
+   printf("\n");
+}
+
+/*  L1 behaviour does not depend on L2, so a sweep over L2 configs simulates L1
+    once, recording every request handleL1Miss sends down (writebacks + demand
+    misses), then replays that stream against each L2 config in parallel.
+    Output per config is identical to a normal run with the same parameters.
+
+    Example:
+    ./sim -sweep 32 1024 2 gcc_trace.txt 8192,4 16384,4 32768,8
+*/
+static int runL2Sweep(int argc, char *argv[]) {
+   FILE *fp;
+   char *trace_file;
+   cache_params_t params;
+   char rw;
+   uint32_t addr;
+
+   if (argc < 7) {
+      printf("Error: Usage: %s -sweep <BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <trace_file> <L2_SIZE>,<L2_ASSOC> [...]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   params.BLOCKSIZE = (uint32_t) atoi(argv[2]);
+   params.L1_SIZE   = (uint32_t) atoi(argv[3]);
+   params.L1_ASSOC  = (uint32_t) atoi(argv[4]);
+   params.L2_SIZE   = 0;
+   params.L2_ASSOC  = 0;
+   params.PREF_N    = 0;
+   params.PREF_M    = 0;
+   trace_file       = argv[5];
+
+   // Parse L2 configs ("size,assoc")
+   std::vector<cache_params_t> configs;
+   for (int i = 6; i < argc; i++) {
+      cache_params_t cfg = params;
+      if (sscanf(argv[i], "%u,%u", &cfg.L2_SIZE, &cfg.L2_ASSOC) != 2 || cfg.L2_SIZE == 0 || cfg.L2_ASSOC == 0) {
+         printf("Error: Bad L2 config %s (expected <L2_SIZE>,<L2_ASSOC>).\n", argv[i]);
+         exit(EXIT_FAILURE);
+      }
+      configs.push_back(cfg);
+   }
+
+   fp = fopen(trace_file, "r");
+   if (fp == (FILE *) NULL) {
+      printf("Error: Unable to open file %s\n", trace_file);
+      exit(EXIT_FAILURE);
+   }
+
+   // 1. Simulate L1 alone, recording its outbound request stream
+   L1MissStream stream;
+   CacheSimulator recorder(params, false);
+   recorder.recordMissStream(&stream);
+
+   TraceReader reader(fp);
+   while (reader.next(rw, addr)) {
+      if (rw == 'r' || rw == 'w') {
+         recorder.processMemoryAccess(addr, rw);
+      } else {
+         printf("Error: Unknown request type %c.\n", rw);
+         exit(EXIT_FAILURE);
+      }
+   }
+   fclose(fp);
+
+   // 2. Replay the stream against every L2 config (one worker per core)
+   std::vector<CacheSimulator*> sims;
+   for (size_t i = 0; i < configs.size(); i++) {
+      sims.push_back(new CacheSimulator(configs[i], false));
+   }
+
+   std::atomic<size_t> next_config(0);
+   auto worker = [&]() {
+      size_t i;
+      while ((i = next_config++) < sims.size()) {
+         sims[i]->replayMissStream(stream, recorder.getL1Cache());
+      }
+   };
+
+   size_t num_threads = std::thread::hardware_concurrency();
+   if (num_threads == 0) num_threads = 1;
+   if (num_threads > sims.size()) num_threads = sims.size();
+
+   std::vector<std::thread> threads;
+   for (size_t t = 1; t < num_threads; t++) {
+      threads.push_back(std::thread(worker));
+   }
+   worker();
+   for (size_t t = 0; t < threads.size(); t++) {
+      threads[t].join();
+   }
+
+   // 3. Print results in command-line order (footprint report on stderr)
+   uint64_t packed_bytes = 0, unpacked_bytes = 0;
+   for (size_t i = 0; i < sims.size(); i++) {
+      printConfiguration(configs[i], trace_file);
+      sims[i]->printCacheContents();
+      sims[i]->printFinalStats();
+      packed_bytes += sims[i]->getL2MetadataBytes();
+      unpacked_bytes += sims[i]->getL2UnpackedMetadataBytes();
+      delete sims[i];
+   }
+   fprintf(stderr, "L2 line metadata for %zu configs: %" PRIu64 " bytes packed (incl. high-assoc index), %" PRIu64 " bytes unpacked (%.2fx of unpacked)\n",
+           sims.size(), packed_bytes, unpacked_bytes, unpacked_bytes ? (double)packed_bytes / (double)unpacked_bytes : 0.0);
+
+   return(0);
+}
+
 // =============================================================================
 // EXISTING MAIN FUNCTION (PRESERVED)
 // =============================================================================
@@ -463,6 +1066,39 @@ int main (int argc, char *argv[]) {
    uint32_t addr;		// This variable holds the request's address obtained from the trace.
 				// The header file <inttypes.h> above defines signed and unsigned integers of various sizes in a machine-agnostic way.  "uint32_t" is an unsigned integer of 32 bits.
 
+   bool sampling = false;	// -sample given
+   uint32_t sample_rate = 1;	// Simulate 1 of every sample_rate L1 sets
+   uint32_t sample_seed = 1;	// Which sets (0 = index % rate == 0, else hashed)
+
+   // L2 sweep mode (see runL2Sweep above)
+   if (argc > 1 && strcmp(argv[1], "-sweep") == 0) {
+      return runL2Sweep(argc, argv);
+   }
+
+   // Set sampling mode: ./sim -sample <RATE>[:<SEED>] <normal arguments>
+   // Simulates 1 of every RATE L1 sets and scales the statistics up.
+   // Every trace line is still read, so reading bounds the speedup: about
+   // 2x at RATE 8 and 3x at RATE 32 over a full run (4M-access trace).
+   if (argc > 1 && strcmp(argv[1], "-sample") == 0) {
+      char *end = NULL;
+      unsigned long rate = (argc > 2) ? strtoul(argv[2], &end, 10) : 0;
+      unsigned long seed = sample_seed;
+      if (end != NULL && end != argv[2] && *end == ':') {
+         char *seed_str = end + 1;
+         seed = strtoul(seed_str, &end, 10);
+         if (end == seed_str) end = NULL;
+      }
+      if (end == NULL || end == argv[2] || *end != '\0' || rate == 0 || rate > 0x80000000UL || seed > 0xFFFFFFFFUL) {
+         printf("Error: -sample expects <RATE>[:<SEED>] with RATE a power of two >= 1, got %s.\n", (argc > 2) ? argv[2] : "nothing");
+         exit(EXIT_FAILURE);
+      }
+      sampling = true;
+      sample_rate = (uint32_t) rate;
+      sample_seed = (uint32_t) seed;
+      argc -= 2;
+      argv += 2;
+   }
+
    // Exit with an error if the number of command-line arguments is incorrect.
    if (argc != 9) {
       printf("Error: Expected 8 command-line arguments but was provided %d.\n", (argc - 1));
@@ -487,18 +1123,6 @@ int main (int argc, char *argv[]) {
       exit(EXIT_FAILURE);
    }
     
-   // Print simulator configuration.
-   printf("===== Simulator configuration =====\n");
-   printf("BLOCKSIZE:  %u\n", params.BLOCKSIZE);
-   printf("L1_SIZE:    %u\n", params.L1_SIZE);
-   printf("L1_ASSOC:   %u\n", params.L1_ASSOC);
-   printf("L2_SIZE:    %u\n", params.L2_SIZE);
-   printf("L2_ASSOC:   %u\n", params.L2_ASSOC);
-   printf("PREF_N:     %u\n", params.PREF_N);
-   printf("PREF_M:     %u\n", params.PREF_M);
-   printf("trace_file: %s\n", trace_file);
-   printf("\n");
-
    // =============================================================================
    // NEW CACHE SIMULATOR INTEGRATION
    // =============================================================================
@@ -506,9 +1130,21 @@ int main (int argc, char *argv[]) {
    // Create cache simulator instance
    // Set debug_mode to false for final runs (true for detailed debugging)
    CacheSimulator simulator(params, false);
+   if (sampling && !simulator.setSampleRate(sample_rate, sample_seed)) {
+      printf("Error: Sample rate %u must be a power of two dividing the L1/L2 set counts and leaving at least 2 sampled clusters.\n", sample_rate);
+      exit(EXIT_FAILURE);
+   }
+   
+   // Print simulator configuration.
+   printConfiguration(params, trace_file);
    
    // Read requests from the trace file and process them through the cache simulator
-   while (fscanf(fp, "%c %x\n", &rw, &addr) == 2) {	// Stay in the loop if fscanf() successfully parsed two tokens as specified.
+   TraceReader reader(fp);
+   if (sampling) {
+      // Drop unsampled lines before they are fully parsed
+      reader.setSampleFilter(simulator.getSampleShift(), simulator.getSampledResidues());
+   }
+   while (reader.next(rw, addr)) {	// Stay in the loop while a full "<rw> <addr>" request was parsed.
       if (rw == 'r' || rw == 'w') {
          // Process the memory access through our cache simulator
          simulator.processMemoryAccess(addr, rw);
@@ -520,10 +1156,16 @@ int main (int argc, char *argv[]) {
    
    // Close the trace file
    fclose(fp);
+   simulator.addSkippedAccesses(reader.getFilteredLines());
    
-   // Print final cache contents and statistics
-   simulator.printCacheContents();
+   // Print final cache contents and statistics (contents are partial when sampling)
+   if (!sampling) {
+      simulator.printCacheContents();
+   }
    simulator.printFinalStats();
+   if (sampling) {
+      simulator.printSamplingStats();
+   }
 
    return(0);
 }
@@ -1,9 +1,15 @@
 #ifndef SIM_CACHE_H
 #define SIM_CACHE_H
 
+#include <stdio.h>
 #include <vector>
 #include <inttypes.h>
 
+// Sets with more ways than this use HighAssocIndex (O(1) lookup/LRU)
+#ifndef HIGH_ASSOC_THRESHOLD
+#define HIGH_ASSOC_THRESHOLD 64
+#endif
+
 typedef 
 struct {
    uint32_t BLOCKSIZE;
@@ -19,7 +25,7 @@ struct {
 // DATA STRUCTURES
 // =============================================================================
 
-// Single cache line 
+// Single cache line (unpacked view, see LineFormat for storage)
 struct CacheLine {
     bool valid;              
     bool dirty;             
@@ -29,19 +35,110 @@ struct CacheLine {
     CacheLine() : valid(false), dirty(false), tag(0), lru_position(0) {}
 };
 
+// Packed line layout, LSB first: [valid:1][dirty:1][lru rank:lru_bits][tag:tag_bits]
+// A line is one 32-bit word when it fits, else two words (64-bit line).
+struct LineFormat {
+    uint32_t lru_bits;        // ceil(log2(assoc)); 0 when HighAssocIndex keeps LRU order
+    uint32_t tag_shift;       // 2 + lru_bits
+    uint32_t words_per_line;  // 1 or 2 uint32_t words
+    uint64_t lru_mask;        // Rank field (in place)
+    uint64_t tag_mask;        // Tag field (in place)
+};
+
+// Lookup structures for high-associativity sets (e.g. fully-associative), one
+// flat array for the whole cache. Replaces the per-way scans; each set owns
+// `stride` entries:
+//   [table_size slots][assoc + 1 prev links][assoc + 1 next links][fill count]
+// Slots are an open-addressed tag -> way table (way + 1, 0 = empty; tags are
+// read from the packed lines). Links form a circular LRU list through the
+// sentinel node `assoc` (next = MRU, prev = LRU). Lines are only invalidated
+// by reset, so the invalid ways are exactly [fill count, assoc).
+struct HighAssocIndex {
+    uint32_t table_size;      // Slots per set: 1.5 * assoc (load factor <= 2/3)
+    uint32_t prev_offset;     // Entry offsets within a set
+    uint32_t next_offset;
+    uint32_t fill_offset;
+    size_t stride;            // Entries per set (0 = index not used)
+    std::vector<uint16_t> narrow;  // Entries while assoc < 65536
+    std::vector<uint32_t> wide;    // Entries otherwise
+    
+    HighAssocIndex() : table_size(0), prev_offset(0), next_offset(0), fill_offset(0), stride(0) {}
+    void init(uint32_t num_sets, uint32_t assoc);
+    
+    uint32_t get(size_t i) const { return narrow.empty() ? wide[i] : narrow[i]; }
+    void put(size_t i, uint32_t value) {
+        if (narrow.empty()) wide[i] = value; else narrow[i] = (uint16_t)value;
+    }
+    uint64_t bytes() const { return narrow.size() * sizeof(uint16_t) + wide.size() * sizeof(uint32_t); }
+};
+
+// Request L1 sends down the hierarchy (as issued by handleL1Miss)
+struct L1Request {
+    uint32_t address;        // Block address sent to L2
+    char rw;                 // 'r' = demand miss, 'w' = writeback
+};
+
 class CacheSet;
 class Cache;
 class CacheSimulator;
 
-// Manages set-associative caches
+// Recorded L1 outbound request stream; replayed against many L2 configs
+class L1MissStream {
+private:
+    std::vector<L1Request> requests;  // In issue order
+    
+public:
+    void record(uint32_t address, char rw) { requests.push_back({address, rw}); }
+    size_t size() const { return requests.size(); }
+    const L1Request& operator[](size_t i) const { return requests[i]; }
+};
+
+// View of one set's packed lines (storage is owned by Cache)
 class CacheSet {
 private:
-    std::vector<CacheLine> lines;    // Array of cache lines in this set
+    uint32_t* words;                 // Packed lines of this set
     uint32_t associativity;          // Number of ways in this set
+    const LineFormat* format;        // Field layout shared by all sets
+    HighAssocIndex* index;           // nullptr unless assoc > HIGH_ASSOC_THRESHOLD
+    size_t index_base;               // This set's first entry in index
+    
+    static const uint64_t VALID_BIT = 1;
+    static const uint64_t DIRTY_BIT = 2;
+    
+    uint64_t load(uint32_t way) {
+        if (format->words_per_line == 1) return words[way];
+        return words[2 * way] | ((uint64_t)words[2 * way + 1] << 32);
+    }
+    void store(uint32_t way, uint64_t line) {
+        if (format->words_per_line == 1) {
+            words[way] = (uint32_t)line;
+        } else {
+            words[2 * way] = (uint32_t)line;
+            words[2 * way + 1] = (uint32_t)(line >> 32);
+        }
+    }
+    uint32_t lruOf(uint64_t line) { return (uint32_t)((line & format->lru_mask) >> 2); }
+    uint32_t tagOf(uint64_t line) { return (uint32_t)(line >> format->tag_shift); }
+    
+    // HighAssocIndex helpers (list sentinel node == associativity)
+    uint32_t entry(uint32_t i) { return index->get(index_base + i); }
+    void setEntry(uint32_t i, uint32_t value) { index->put(index_base + i, value); }
+    uint32_t prevOf(uint32_t node) { return entry(index->prev_offset + node); }
+    uint32_t nextOf(uint32_t node) { return entry(index->next_offset + node); }
+    void setPrev(uint32_t node, uint32_t value) { setEntry(index->prev_offset + node, value); }
+    void setNext(uint32_t node, uint32_t value) { setEntry(index->next_offset + node, value); }
+    uint32_t homeSlot(uint32_t tag) { return (uint32_t)(((uint64_t)(tag * 0x9E3779B1u) * index->table_size) >> 32); }
+    uint32_t nextSlot(uint32_t slot) { return (slot + 1 == index->table_size) ? 0 : slot + 1; }
+    void unlinkWay(uint32_t way);
+    void pushMRU(uint32_t way);
+    void tableInsert(uint32_t tag, uint32_t way);
+    void tableErase(uint32_t tag);
     
 public:
     // Constructor
-    CacheSet(uint32_t assoc);
+    CacheSet(uint32_t* set_words, uint32_t assoc, const LineFormat* fmt, HighAssocIndex* idx, size_t idx_base)
+        : words(set_words), associativity(assoc), format(fmt), index(idx), index_base(idx_base) {}
+    void reset();
     
     // Core functionality
     bool findLine(uint32_t tag, uint32_t& way);
@@ -53,7 +150,7 @@ public:
     
     // DEBUG INFO
     void displaySet(uint32_t set_index);
-    CacheLine& getLine(uint32_t way) { return lines[way]; }
+    CacheLine getLine(uint32_t way);
 };
 
 // Main cache for direct-mapped and set-associative config
@@ -63,7 +160,11 @@ private:
     uint32_t block_size;      // (bytes)
     uint32_t associativity;   // Ways per set (1 = direct mapped)
     uint32_t num_sets;        
-    std::vector<CacheSet> sets; // Array of cache sets
+    
+    // Packed line metadata for all sets (set i starts at i * assoc * words_per_line)
+    LineFormat line_format;
+    std::vector<uint32_t> line_words;
+    HighAssocIndex high_assoc_index;        // Used (stride > 0) if assoc > HIGH_ASSOC_THRESHOLD
     
     // Bit field calc 4 addr parsing
     uint32_t offset_bits;     // (bits)
@@ -81,6 +182,11 @@ private:
 
     // Private helper methods
     void calculateBitFields();
+    void calculateLineFormat();
+    CacheSet set(uint32_t index) {
+        return CacheSet(&line_words[(size_t)index * associativity * line_format.words_per_line], associativity, &line_format,
+                        high_assoc_index.stride ? &high_assoc_index : nullptr, (size_t)index * high_assoc_index.stride);
+    }
     
 public:
 
@@ -96,6 +202,7 @@ public:
     void printStats(const char* cache_name);
     void displayContents(const char* cache_name);
     double getMissRate();
+    double getReadMissRate();  // Read misses / reads (the L2 "miss rate")
     uint64_t getTotalMisses();
     uint64_t getWritebacks() { return writebacks; }
     
@@ -103,6 +210,11 @@ public:
     uint32_t getNumSets() { return num_sets; }
     uint32_t getAssociativity() { return associativity; }
     uint32_t getBlockSize() { return block_size; }
+    uint32_t getOffsetBits() { return offset_bits; }
+    
+    // Line metadata footprint (bytes): packed (+ HighAssocIndex) vs. one CacheLine per way
+    uint64_t getMetadataBytes() { return (uint64_t)line_words.size() * sizeof(uint32_t) + high_assoc_index.bytes(); }
+    uint64_t getUnpackedMetadataBytes() { return (uint64_t)num_sets * associativity * sizeof(CacheLine); }
     
     // Getters for stats
     uint64_t getReadAccesses() { return read_accesses; }
@@ -113,6 +225,36 @@ public:
     uint64_t getWriteMisses() { return write_misses; }
 };
 
+// Buffered trace reader for "<r|w> <hex address>" lines; replaces
+// fscanf("%c %x\n"). With a sample filter, unsampled lines are skipped
+// from their last few hex digits, but every line is still scanned.
+class TraceReader {
+private:
+    FILE* fp;
+    std::vector<char> buffer;
+    size_t pos;               // Next unread byte in buffer
+    size_t len;               // Valid bytes in buffer
+    
+    // Sampling pre-filter: skip lines whose (addr >> filter_shift) residue isn't kept
+    const std::vector<uint8_t>* filter_keep;  // nullptr = no filter
+    uint32_t filter_shift;
+    uint32_t filter_digits;   // Trailing hex digits that decide the residue
+    uint64_t filtered_lines;  // Lines skipped by the filter
+    
+    bool fill();              // Refill when fewer than one max-length line remains
+    bool skipFiltered();      // Skip rejected lines; false at end of trace
+    
+public:
+    TraceReader(FILE* file);
+    
+    // Next request; false at end of trace or on a malformed line (like fscanf != 2)
+    bool next(char& rw, uint32_t& addr);
+    
+    // Skip unsampled lines before the full parse (keep.size() is a power of two)
+    void setSampleFilter(uint32_t shift, const std::vector<uint8_t>* keep);
+    uint64_t getFilteredLines() { return filtered_lines; }
+};
+
 // Manages the L1/L2 hierarchy
 class CacheSimulator {
 private:
@@ -130,6 +272,23 @@ private:
     bool debug_mode;          // Enable detailed per-access output
     uint64_t access_count;    // Counter for access numbering
     
+    // L2 sweep support
+    L1MissStream* miss_stream; // Records L1 outbound requests (nullptr = off)
+    
+    // Set sampling: simulate only L1 sets whose index residue is selected
+    bool sampling;             // -sample mode active
+    uint32_t sample_rate;      // Simulate 1 of every sample_rate sets
+    uint32_t sample_seed;      // 0 = residues 0 mod rate, else hashed choice
+    uint32_t sample_modulus;   // min(L1, L2) set count: selection uses index % this
+    std::vector<uint8_t> residue_sampled;  // [sample_modulus] 1 = simulate
+    std::vector<uint32_t> sampled_residues; // Selected residues (sampling clusters)
+    uint64_t skipped_accesses; // Accesses to unsampled sets
+    std::vector<uint64_t> cluster_accesses; // Per residue, for confidence intervals
+    std::vector<uint64_t> cluster_misses;
+    std::vector<uint64_t> cluster_traffic;
+    std::vector<uint64_t> cluster_l2_accesses;
+    std::vector<uint64_t> cluster_l2_misses;
+    
 public:
     // Constructor and destructor
     CacheSimulator(const cache_params_t& params, bool debug = false);
@@ -138,14 +297,34 @@ public:
     // Main sim method
     void processMemoryAccess(uint32_t address, char rw);
     
+    // L2 sweep: record L1's outbound stream once, replay it per L2 config
+    void recordMissStream(L1MissStream* stream) { miss_stream = stream; }
+    void replayMissStream(const L1MissStream& stream, const Cache& l1_snapshot);
+    const Cache& getL1Cache() { return *L1_cache; }
+    
+    // Set sampling trace pre-filter: residue = (addr >> shift) & (residues.size() - 1)
+    uint32_t getSampleShift() { return L1_cache->getOffsetBits(); }
+    const std::vector<uint8_t>* getSampledResidues() { return &residue_sampled; }
+    void addSkippedAccesses(uint64_t n) { total_accesses += n; access_count += n; skipped_accesses += n; }
+    uint64_t getL2MetadataBytes() { return L2_cache ? L2_cache->getMetadataBytes() : 0; }
+    uint64_t getL2UnpackedMetadataBytes() { return L2_cache ? L2_cache->getUnpackedMetadataBytes() : 0; }
+    
+    // Set sampling: false unless rate is a power of two that divides both
+    // set counts and leaves at least 2 sampled residues
+    bool setSampleRate(uint32_t rate, uint32_t seed);
+    
     // Output methods
     void printFinalStats();
     void printCacheContents();
+    void printSamplingStats();
     
 private:
     // Helpers
     void handleL1Miss(uint32_t address, char rw, bool writeback_needed, uint32_t writeback_addr);
     void handleL2Miss(uint32_t address, char rw, bool writeback_needed, uint32_t writeback_addr);
+    void accessL2(uint32_t address, char rw);
+    void simulateAccess(uint32_t address, char rw);
+    uint64_t memoryTraffic();
     void printDebugAccess(uint32_t address, char rw, const char* cache_name, uint32_t tag, uint32_t index, bool hit);
 };
 
@@ -0,0 +1,114 @@
+#!/bin/bash
+
+# =============================================================================
+# ECE 492 Cache Simulator Set-Sampling Validation
+# =============================================================================
+# Runs every trace in traces/ both fully and with "-sample RATE:SEED", then
+# checks that the full-run L1 miss rate, L2 miss rate and memory traffic fall
+# inside the sampled run's 95% confidence interval.
+#
+# Usage: ./validate_sampling.sh [RATE ...]      (default rates: 4 8)
+#        SEEDS="1 2 3" selects the hashed set choices tried per rate.
+# Each trace is concatenated SAMPLE_TRACE_REPEAT times (default 10, ~1M
+# accesses), as in perf_check.sh, so cold-start misses don't dominate.
+#
+# A value is "ok" when the full run is inside the sampled CI, "outside" when
+# within GROSS_CI_MULT (default 3) half-widths, else "GROSS". Half-widths are
+# widened by one unit of the printed precision (a CI printed as 0.0000 is
+# only known to be < 0.00005). Fails if any CI is undefined, if coverage is
+# below MIN_COVERAGE (default 0.85; nominal 0.95), or if more than
+# MAX_GROSS (default 0.05) of all values are GROSS. A few GROSS values are
+# expected: a handful of hot sets the sample misses biases every seed alike.
+
+cd "$(dirname "$0")"
+
+SIM=$(pwd)/sim
+RATES=${@:-4 8}
+SEEDS=${SEEDS:-1 2 3}
+TRACE_REPEAT=${SAMPLE_TRACE_REPEAT:-10}
+MIN_COVERAGE=${MIN_COVERAGE:-0.85}
+GROSS_CI_MULT=${GROSS_CI_MULT:-3}
+MAX_GROSS=${MAX_GROSS:-0.05}
+
+# BLOCKSIZE L1_SIZE L1_ASSOC L2_SIZE L2_ASSOC PREF_N PREF_M
+CONFIGS=(
+    "32 8192 4 0 0 0 0"
+    "32 8192 2 65536 8 0 0"
+    "64 16384 4 262144 8 0 0"
+)
+
+if [ ! -x $SIM ]; then
+    echo "Building simulator..."
+    make || exit 1
+fi
+
+# value <file> <label>: first number after the label
+value() {
+    grep "$2" "$1" | head -1 | sed 's/.*: *//' | awk '{print $1}'
+}
+
+# halfwidth <file> <label>: number after "+/-"
+halfwidth() {
+    grep "$2" "$1" | head -1 | sed 's/.*+\/- *//'
+}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# Longer traces: each bundled trace repeated TRACE_REPEAT times
+mkdir "$tmp/traces"
+for trace in traces/*_trace.txt; do
+    for i in $(seq $TRACE_REPEAT); do cat "$trace"; done > "$tmp/traces/$(basename "$trace")"
+done
+
+checked=0
+covered=0
+gross=0
+undefined=0
+
+printf "%-18s %-26s %-7s %-15s %10s %10s %9s %8s  %s\n" trace config rate:seed metric full sampled "+/-" rel.err result
+
+for trace in "$tmp"/traces/*.txt; do
+    name=$(basename "$trace" .txt)
+    for config in "${CONFIGS[@]}"; do
+        $SIM $config "$trace" > "$tmp/full.txt" || exit 1
+        for sample in $(for r in $RATES; do for s in $SEEDS; do echo $r:$s; done; done); do
+            if ! $SIM -sample $sample $config "$trace" > "$tmp/sampled.txt"; then
+                echo "$name: -sample $sample not valid for config $config, skipped"
+                continue
+            fi
+
+            for metric in "L1 miss rate" "L2 miss rate" "memory traffic"; do
+                sampled_hw=$(halfwidth "$tmp/sampled.txt" "^$metric (95% CI)")
+                [ -z "$sampled_hw" ] && continue    # No L2 in this config
+                full=$(value "$tmp/full.txt" ". $metric:")
+                sampled=$(value "$tmp/sampled.txt" "^$metric (95% CI)")
+
+                rel_err=$(awk -v f="$full" -v s="$sampled" 'BEGIN {
+                    d = f - s; if (d < 0) d = -d; printf "%.4f", (f > 0) ? d / f : 0 }')
+                result=$(awk -v f="$full" -v s="$sampled" -v h="$sampled_hw" -v k="$GROSS_CI_MULT" 'BEGIN {
+                    if (h == "undefined") { print "undefined"; exit }
+                    # One unit of the printed precision (0.0001 for rates, 1 for traffic)
+                    q = (index(h, ".") > 0) ? 10 ^ -(length(h) - index(h, ".")) : 1;
+                    d = f - s; if (d < 0) d = -d;
+                    if (d <= h + q) print "ok"; else if (d <= k * (h + q)) print "outside"; else print "GROSS" }')
+
+                checked=$((checked + 1))
+                [ "$result" = "ok" ] && covered=$((covered + 1))
+                [ "$result" = "GROSS" ] && gross=$((gross + 1))
+                [ "$result" = "undefined" ] && undefined=$((undefined + 1))
+
+                printf "%-18s %-26s %-7s %-15s %10s %10s %9s %8s  %s\n" \
+                    "$name" "$config" "$sample" "$metric" "$full" "$sampled" "$sampled_hw" "$rel_err" "$result"
+            done
+        done
+    done
+done
+
+pass=$(awk -v c="$covered" -v g="$gross" -v n="$checked" -v mc="$MIN_COVERAGE" -v mg="$MAX_GROSS" 'BEGIN {
+    print (n > 0 && c / n >= mc && g / n <= mg) ? 1 : 0 }')
+
+echo
+echo "===== $covered of $checked full-run values inside the sampled 95% CI (minimum $MIN_COVERAGE)," \
+     "$gross beyond ${GROSS_CI_MULT}x CI (maximum $MAX_GROSS), $undefined undefined CIs ====="
+[ "$pass" -eq 1 ] && [ $undefined -eq 0 ]